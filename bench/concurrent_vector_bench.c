@@ -0,0 +1,77 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+Push throughput of concurrent_vector from 1 to 64 threads, next to a vector guarded by a mutex.
+Build and run: cc -O2 -I src bench/concurrent_vector_bench.c -o cv_bench -lpthread && ./cv_bench [pushes per thread]
+*/
+
+#include <stdio.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "concurrent_vector.h"
+#include "vector.h"
+
+#define MAX_THREADS 64
+
+static size_t pushes = 1000000;
+static concurrent_vector(size_t) cv;
+static vector(size_t) locked;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void* push_concurrent(void* arg) {
+    size_t base = (size_t)arg*pushes;
+    for(size_t i = 0; i < pushes; i++) cv_push_back(cv, base+i);
+    return NULL;
+}
+
+static void* push_locked(void* arg) {
+    size_t base = (size_t)arg*pushes;
+    for(size_t i = 0; i < pushes; i++) {
+        pthread_mutex_lock(&lock);
+        v_push_back(locked, base+i);
+        pthread_mutex_unlock(&lock);
+    }
+    return NULL;
+}
+
+/* returns pushes per second of threads threads running worker */
+static double run(size_t threads, void* (*worker)(void*)) {
+    pthread_t id[MAX_THREADS];
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(size_t t = 0; t < threads; t++) pthread_create(&id[t], NULL, worker, (void*)t);
+    for(size_t t = 0; t < threads; t++) pthread_join(id[t], NULL);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (end.tv_sec-start.tv_sec)+(end.tv_nsec-start.tv_nsec)/1e9;
+    return threads*pushes/seconds;
+}
+
+int main(int argc, char** argv) {
+    if(argc > 1) pushes = strtoull(argv[1], NULL, 10);
+    printf("%7s %22s %22s\n", "threads", "concurrent_vector M/s", "mutex+vector M/s");
+    for(size_t threads = 1; threads <= MAX_THREADS; threads *= 2) {
+        cv_init(cv);
+        double concurrent = run(threads, push_concurrent);
+        cv_free(cv);
+
+        locked = NULL;
+        double mutex = run(threads, push_locked);
+        v_free(locked);
+
+        printf("%7zu %22.1f %22.1f\n", threads, concurrent/1e6, mutex/1e6);
+    }
+    return 0;
+}
@@ -0,0 +1,81 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+Stress test of concurrent_vector: writers push distinct values while a reader samples published elements,
+then every value must be present exactly once. Exits with a non-zero status on failure.
+Build and run: cc -O1 -g -fsanitize=thread -I src bench/concurrent_vector_stress.c -o cv_stress -lpthread && ./cv_stress
+*/
+
+#include <stdio.h>
+#include <pthread.h>
+
+#include "concurrent_vector.h"
+
+#define WRITERS 8
+#define PUSHES 200000
+
+static concurrent_vector(size_t) cv;
+static atomic_int writing;
+static atomic_int failed;
+
+static void* writer(void* arg) {
+    size_t base = (size_t)arg*PUSHES;
+    for(size_t i = 0; i < PUSHES; i++) {
+        size_t index;
+        cv_push_back_index(cv, base+i, index);
+        if(index == NPOS) atomic_store(&failed, 1);
+    }
+    atomic_fetch_sub(&writing, 1);
+    return NULL;
+}
+
+static void* reader(void* arg) {
+    (void)arg;
+    size_t checked = 0;
+    while(atomic_load(&writing)) {
+        size_t size = cv_size(cv);
+        if(!size) continue;
+        size_t n = size-1-(checked*7919 % size);
+        if(cv_ready(cv, n)) {
+            if(cv_at(cv, n) >= (size_t)WRITERS*PUSHES) atomic_store(&failed, 1);
+            checked++;
+        }
+    }
+    return NULL;
+}
+
+int main(void) {
+    pthread_t writers[WRITERS], sampler;
+    cv_init(cv);
+    atomic_init(&writing, WRITERS);
+    atomic_init(&failed, 0);
+    pthread_create(&sampler, NULL, reader, NULL);
+    for(size_t t = 0; t < WRITERS; t++) pthread_create(&writers[t], NULL, writer, (void*)t);
+    for(size_t t = 0; t < WRITERS; t++) pthread_join(writers[t], NULL);
+    pthread_join(sampler, NULL);
+
+    size_t total = (size_t)WRITERS*PUSHES;
+    char* seen = calloc(total, 1);
+    int ok = !atomic_load(&failed) && cv_size(cv) == total;
+    for(size_t i = 0; ok && i < total; i++) {
+        size_t val = cv_at(cv, i);
+        ok = cv_ready(cv, i) && val < total && !seen[val];
+        if(ok) seen[val] = 1;
+    }
+    free(seen);
+    cv_free(cv);
+    puts(ok ? "ok" : "FAILED");
+    return !ok;
+}
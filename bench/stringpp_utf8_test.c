@@ -0,0 +1,117 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+Cross-check of the UTF-8 kernels of stringpp.h: the SSE4.1 and AVX2 validators must agree with the scalar one,
+and the UTF-16 and UTF-32 transcoders with a reference built on stringpp_utf8_decode(), on every combination of
+boundary bytes at every alignment and on random valid and corrupted text. Exits with a non-zero status on failure.
+Build and run: cc -O2 -I src bench/stringpp_utf8_test.c -o utf8_test && ./utf8_test
+*/
+
+#include <stdio.h>
+
+#include "stringpp.h"
+
+#define BUF 96
+#define RANDOM_ROUNDS 20000
+
+static const uint8_t boundary[] = {
+    0x00, 0x41, 0x7F, 0x80, 0x8F, 0x90, 0x9F, 0xA0, 0xBF, 0xC0, 0xC1, 0xC2, 0xDF,
+    0xE0, 0xE1, 0xEC, 0xED, 0xEE, 0xEF, 0xF0, 0xF1, 0xF3, 0xF4, 0xF5, 0xFF
+};
+
+static uint64_t rng = 0x9E3779B97F4A7C15ULL;
+
+static uint32_t rnd(void) {
+    rng ^= rng<<13, rng ^= rng>>7, rng ^= rng<<17;
+    return (uint32_t)(rng>>32);
+}
+
+/* reference transcoding, one code point at a time; returns NPOS on invalid input like the kernels */
+static size_t reference(const char* s, size_t len, uint16_t* u16, size_t* n16, uint32_t* u32) {
+    size_t n = 0, m = 0;
+    for(size_t i = 0; i < len;) {
+        uint32_t cp = stringpp_utf8_decode(s, len, &i);
+        if(cp == STRING_UTF8_INVALID) return NPOS;
+        u32[n++] = cp;
+        if(cp >= 0x10000) {
+            u16[m++] = (uint16_t)(0xD800 | ((cp-0x10000)>>10));
+            u16[m++] = (uint16_t)(0xDC00 | ((cp-0x10000) & 0x3FF));
+        } else u16[m++] = (uint16_t)cp;
+    }
+    *n16 = m;
+    return n;
+}
+
+static int check(const char* s, size_t len) {
+    static uint16_t u16[BUF*4], e16[BUF*4];
+    static uint32_t u32[BUF*4], e32[BUF*4];
+    int valid = stringpp_utf8_validate_scalar(s, len);
+#ifdef STRING_UTF8_X86
+    if(__builtin_cpu_supports("sse4.1") && stringpp_utf8_validate_sse4(s, len) != valid) return 0;
+    if(__builtin_cpu_supports("avx2") && stringpp_utf8_validate_avx2(s, len) != valid) return 0;
+#endif
+    size_t n16 = 0, n32 = reference(s, len, e16, &n16, e32);
+    if((n32 != NPOS) != valid) return 0;
+    size_t r16 = stringpp_utf8_to_utf16(s, len, u16), r32 = stringpp_utf8_to_utf32(s, len, u32);
+    if(n32 == NPOS) return r16 == NPOS && r32 == NPOS;
+    return r16 == n16 && r32 == n32
+        && (n16 == 0 || memcmp(u16, e16, n16*sizeof(*u16)) == 0)
+        && (n32 == 0 || memcmp(u32, e32, n32*sizeof(*u32)) == 0);
+}
+
+int main(void) {
+    const size_t P = sizeof(boundary);
+    char buf[BUF];
+    size_t cases = 0;
+    int ok = 1;
+
+    /* every 4 byte window of boundary bytes, embedded in ASCII at a varying offset so it crosses block edges */
+    for(size_t a = 0; ok && a < P; a++) for(size_t b = 0; ok && b < P; b++)
+    for(size_t c = 0; ok && c < P; c++) for(size_t d = 0; ok && d < P; d++) {
+        size_t off = (a*7+b*3+c) % (BUF-4);
+        memset(buf, 'x', BUF);
+        buf[off] = (char)boundary[a], buf[off+1] = (char)boundary[b];
+        buf[off+2] = (char)boundary[c], buf[off+3] = (char)boundary[d];
+        for(size_t len = off+1; ok && len <= BUF; len += len < off+5 ? 1 : 29, cases++) ok = check(buf, len);
+        if(!ok) printf("mismatch on %02x %02x %02x %02x at offset %zu\n", boundary[a], boundary[b], boundary[c], boundary[d], off);
+    }
+
+    /* random text mixing all sequence lengths, checked whole and after corrupting one byte */
+    for(size_t r = 0; ok && r < RANDOM_ROUNDS; r++) {
+        size_t len = 0;
+        while(len+4 <= BUF) {
+            uint32_t k = rnd() % 5, cp;
+            if(k == 0) cp = 0x80+rnd() % 0x780;
+            else if(k == 1) cp = 0x800+rnd() % 0xF800;
+            else if(k == 2) cp = 0x10000+rnd() % 0x100000;
+            else cp = rnd() % 0x80;
+            size_t n = stringpp_utf8_encode(cp, buf+len);
+            if(n == 0) n = stringpp_utf8_encode('?', buf+len);
+            len += n;
+            if(rnd() % 16 == 0) break;
+        }
+        ok = check(buf, len);
+        if(ok && len) {
+            buf[rnd() % len] = (char)boundary[rnd() % P];
+            ok = check(buf, len);
+        }
+        cases += 2;
+        if(!ok) printf("mismatch on random text of %zu bytes\n", len);
+    }
+
+    printf("%zu cases\n", cases);
+    puts(ok ? "ok" : "FAILED");
+    return !ok;
+}
@@ -0,0 +1,247 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#ifndef cv_stdlib
+#define cv_stdlib
+#include <stdlib.h> // malloc() calloc() free()
+#endif // #ifndef cv_stdlib
+
+#ifndef cv_string
+#define cv_string
+#include <string.h> // memset()
+#endif // #ifndef cv_string
+
+#ifndef cv_stdatomic
+#define cv_stdatomic
+#include <stdatomic.h> // atomic_fetch_add() atomic_load() atomic_compare_exchange_strong()
+#endif // #ifndef cv_stdatomic
+
+/**
+ * @brief NPOS is a constant value with the greatest possible value for an element of type size_t.
+ *        As a return value, it is usually used to indicate no matches.
+ */
+#ifndef NPOS
+#define NPOS -1ULL
+#endif // #ifndef NPOS
+
+/**
+ * @brief Segment k of a concurrent vector holds DEFAULT_CONCURRENT_VECTOR_CAPACITY<<k elements,
+ *        so every segment is as large as all the previous ones together (plus the first one).
+ *        CONCURRENT_VECTOR_SEGMENTS segments are enough to address the whole size_t range.
+ *        Each segment is followed by one ready flag per element, see cv_ready().
+ * @private
+ */
+#define CONCURRENT_VECTOR_CAPACITY_LOG2 5
+#define DEFAULT_CONCURRENT_VECTOR_CAPACITY (1ULL<<CONCURRENT_VECTOR_CAPACITY_LOG2)
+#define CONCURRENT_VECTOR_SEGMENTS (64-CONCURRENT_VECTOR_CAPACITY_LOG2)
+
+/**
+ * @brief Number of times a push re-reads a segment that isn't published yet before allocating it itself
+ */
+#ifndef CONCURRENT_VECTOR_SPIN
+#define CONCURRENT_VECTOR_SPIN 256
+#endif // #ifndef CONCURRENT_VECTOR_SPIN
+
+/**
+ * @brief Declaration of concurrent vector type.
+ *        Elements live in a table of exponentially sized segments which are never reallocated,
+ *        so once written an element never moves and pointers to it stay valid until cv_free().
+ */
+#define concurrent_vector(T)                              \
+    struct {                                              \
+        _Atomic size_t size;                              \
+        _Atomic(T*) segments[CONCURRENT_VECTOR_SEGMENTS]; \
+    }*
+
+/**
+ * @brief Returns the index of the segment holding element n
+ * @param {size_t} n
+ * @return {size_t}
+ * @private
+ */
+#define cv_segment_of(n) \
+    ((size_t)(63-__builtin_clzll((n)+DEFAULT_CONCURRENT_VECTOR_CAPACITY)-CONCURRENT_VECTOR_CAPACITY_LOG2))
+
+/**
+ * @brief Returns the position of element n within its segment
+ * @param {size_t} n
+ * @return {size_t}
+ * @private
+ */
+#define cv_segment_offset(n) \
+    ((n)+DEFAULT_CONCURRENT_VECTOR_CAPACITY-(DEFAULT_CONCURRENT_VECTOR_CAPACITY<<cv_segment_of(n)))
+
+/**
+ * @brief Returns the ready flags stored after the elements of segment seg, whose index is s
+ * @param {T*} seg
+ * @param {size_t} s
+ * @return {atomic_uchar*}
+ * @private
+ */
+#define cv_segment_flags(seg, s) \
+    ((atomic_uchar*)((seg)+(DEFAULT_CONCURRENT_VECTOR_CAPACITY<<(s))))
+
+/**
+ * @brief Allocates segment s with all its ready flags cleared, stores NULL in seg if memory runs out
+ * @param {T*} seg
+ * @param {size_t} s
+ * @private
+ */
+#define cv_segment_alloc(seg, s)                                                      \
+    do {                                                                              \
+        size_t cv_cap = DEFAULT_CONCURRENT_VECTOR_CAPACITY<<(s);                      \
+        seg = malloc(cv_cap*(sizeof(*seg)+sizeof(atomic_uchar)));                     \
+        if(seg) { memset(cv_segment_flags(seg, s), 0, cv_cap*sizeof(atomic_uchar)); } \
+    } while(0)
+
+/**
+ * @brief Allocates segment s and publishes it unless another thread did first, in which case the copy is freed.
+ *        Stores the published segment in seg, or NULL if memory ran out and no other thread published it.
+ * @param {concurrent_vector} cv
+ * @param {size_t} s
+ * @param {T*} seg
+ * @private
+ */
+#define cv_segment_install(cv, s, seg)                                                                    \
+    do {                                                                                                  \
+        typeof(seg) cv_new;                                                                               \
+        cv_segment_alloc(cv_new, s);                                                                      \
+        seg = NULL;                                                                                       \
+        if(!cv_new) seg = atomic_load_explicit(&cv->segments[s], memory_order_acquire);                   \
+        else if(atomic_compare_exchange_strong_explicit(&cv->segments[s], &seg, cv_new,                  \
+                                                        memory_order_acq_rel, memory_order_acquire)) {    \
+            seg = cv_new;                                                                                 \
+        } else free(cv_new);                                                                              \
+    } while(0)
+
+/**
+ * @brief Initializes an empty concurrent vector and allocates its first segment.
+ *        Unlike other containers it isn't created lazily, it must be initialized before it is shared between threads.
+ * @param {concurrent_vector} cv
+ */
+#define cv_init(cv)                                                          \
+    do {                                                                     \
+        cv = calloc(1, sizeof(*cv));                                         \
+        if(cv) {                                                             \
+            typeof(atomic_load(&cv->segments[0])) cv_seg;                    \
+            atomic_init(&cv->size, 0);                                       \
+            for(size_t cv_s = 0; cv_s < CONCURRENT_VECTOR_SEGMENTS; cv_s++)  \
+                atomic_init(&cv->segments[cv_s], NULL);                      \
+            cv_segment_alloc(cv_seg, 0);                                     \
+            atomic_init(&cv->segments[0], cv_seg);                           \
+        }                                                                    \
+    } while(0)
+
+/**
+ * @brief Destructs a concurrent vector. Must not run concurrently with any other operation on it.
+ * @param {concurrent_vector} cv
+ */
+#define cv_free(cv)                                                                        \
+    do {                                                                                   \
+        for(size_t cv_s = 0; cv_s < CONCURRENT_VECTOR_SEGMENTS; cv_s++)                    \
+            free(atomic_load_explicit(&cv->segments[cv_s], memory_order_relaxed));         \
+        free(cv);                                                                          \
+        cv = NULL;                                                                         \
+    } while(0)
+
+/**
+ * @brief Returns the number of slots reserved in the concurrent vector.
+ *        A slot is reserved before its element is written, so while pushes are in flight the last elements may
+ *        not be readable yet: concurrent readers must check cv_ready() before cv_at(). Once the pushing threads
+ *        are joined every slot is ready, except those of pushes that reported NPOS.
+ * @param {concurrent_vector} cv
+ * @return {size_t}
+ */
+#define cv_size(cv) \
+    (cv ? atomic_load_explicit(&cv->size, memory_order_acquire) : 0)
+
+/**
+ * @brief Returns whether the concurrent vector is empty (i.e. whether its size is 0).
+ * @param {concurrent_vector} cv
+ * @return {bool}
+ */
+#define cv_empty(cv) \
+    (cv_size(cv) == 0)
+
+/**
+ * @brief Returns whether element n has been written and can be read with cv_at(), safe to call while other threads push.
+ *        A true result synchronizes with the push that wrote the element.
+ * @param {concurrent_vector} cv
+ * @param {size_t} n
+ * @return {bool}
+ */
+#define cv_ready(cv, n)                                                                                                              \
+    ((n) < cv_size(cv)                                                                                                               \
+     && atomic_load_explicit(&cv->segments[cv_segment_of(n)], memory_order_acquire)                                                 \
+     && atomic_load_explicit(&cv_segment_flags(atomic_load_explicit(&cv->segments[cv_segment_of(n)],                                 \
+                                                                    memory_order_relaxed), cv_segment_of(n))                         \
+                             [cv_segment_offset(n)], memory_order_acquire))
+
+/**
+ * @brief Returns a reference to the element at position n in the concurrent vector.
+ *        While other threads push, only elements for which cv_ready() returned true may be accessed.
+ * @param {concurrent_vector} cv
+ * @param {size_t} n
+ * @return {typeof(**cv->segments)}
+ */
+#define cv_at(cv, n) \
+    (atomic_load_explicit(&cv->segments[cv_segment_of(n)], memory_order_acquire)[cv_segment_offset(n)])
+
+/**
+ * @brief Adds a new element at the end of the concurrent vector and stores its position in index, or NPOS if memory ran out.
+ *        Safe to call from any number of threads at once: the slot is reserved with a single atomic fetch-add and no lock
+ *        is taken. The thread reserving the middle slot of a segment allocates the next one, so it is normally published
+ *        long before any thread reaches it. A thread which still finds its segment missing after CONCURRENT_VECTOR_SPIN
+ *        reads allocates it itself and publishes it with a compare-exchange, freeing its copy if another thread won,
+ *        so no push ever waits for another thread's allocation.
+ *        The element is published by setting its ready flag with release semantics.
+ * @param {concurrent_vector} cv
+ * @param {typeof(**cv->segments)} val
+ * @param {size_t} index
+ */
+#define cv_push_back_index(cv, val, index)                                                                            \
+    do {                                                                                                              \
+        size_t cv_n = atomic_fetch_add_explicit(&cv->size, 1, memory_order_relaxed);                                  \
+        size_t cv_s = cv_segment_of(cv_n), cv_off = cv_segment_offset(cv_n);                                          \
+        typeof(atomic_load(&cv->segments[0])) cv_seg = atomic_load_explicit(&cv->segments[cv_s], memory_order_acquire); \
+        for(int cv_spin = 0; !cv_seg && cv_spin < CONCURRENT_VECTOR_SPIN; cv_spin++)                                  \
+            cv_seg = atomic_load_explicit(&cv->segments[cv_s], memory_order_acquire);                                 \
+        if(!cv_seg) cv_segment_install(cv, cv_s, cv_seg);                                                             \
+        if(cv_seg) {                                                                                                  \
+            cv_seg[cv_off] = (val);                                                                                   \
+            atomic_store_explicit(&cv_segment_flags(cv_seg, cv_s)[cv_off], 1, memory_order_release);                  \
+            (index) = cv_n;                                                                                           \
+        } else (index) = NPOS;                                                                                        \
+        if(cv_off == (DEFAULT_CONCURRENT_VECTOR_CAPACITY<<cv_s)/2 && cv_s+1 < CONCURRENT_VECTOR_SEGMENTS              \
+           && !atomic_load_explicit(&cv->segments[cv_s+1], memory_order_relaxed)) {                                   \
+            typeof(cv_seg) cv_next;                                                                                   \
+            cv_segment_install(cv, cv_s+1, cv_next);                                                                  \
+            (void)cv_next;                                                                                            \
+        }                                                                                                             \
+    } while(0)
+
+/**
+ * @brief Adds a new element at the end of the concurrent vector.
+ *        Safe to call from any number of threads at once, see cv_push_back_index().
+ * @param {concurrent_vector} cv
+ * @param {typeof(**cv->segments)} val
+ */
+#define cv_push_back(cv, val)                     \
+    do {                                          \
+        size_t cv_index;                          \
+        cv_push_back_index(cv, val, cv_index);    \
+        (void)cv_index;                           \
+    } while(0)
@@ -0,0 +1,161 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include "flat_set.h" // flat_sort() flat_unique() flat_lower_bound() flat_eytzinger_find() ...
+
+/**
+ * @brief Key accessor of flat_map, elements are ordered by their key member
+ * @private
+ */
+#define FLAT_MAP_KEY(element) ((element).key)
+
+/**
+ * @brief Standardization of the syntax for definition of a flat_map.
+ *        A flat_map is a vector of key-value pairs kept sorted by key and free of duplicate keys.
+ * @param {Type} K
+ * @param {Type} V
+ */
+#define flat_map(K, V) \
+    struct {           \
+        K key;         \
+        V value;       \
+    }*
+
+/**
+ * @brief Standardization of the syntax for definition of a read-optimized Eytzinger layout of a flat_map.
+ *        Declare it with typeof(map) so both share the same pair type.
+ */
+#define flat_map_eytzinger(map) typeof(map)
+
+/**
+ * @brief Destructs a flat_map
+ * @param {flat_map} map
+ */
+#define flat_map_free(map) \
+    v_free(map)
+
+/**
+ * @brief Returns the number of key-value pairs in the flat_map.
+ * @param {flat_map} map
+ * @return size_t
+ */
+#define flat_map_size(map) \
+    v_size(map)
+
+/**
+ * @brief Checks whether there are any key-value pairs in flat_map
+ * @param {flat_map} map
+ * @return boolean
+ */
+#define flat_map_empty(map) \
+    v_empty(map)
+
+/**
+ * @brief Returns a pointer to the pair with the smallest key.
+ * @param {flat_map} map
+ * @return {typeof(map)}
+ */
+#define flat_map_begin(map) \
+    (map)
+
+/**
+ * @brief Returns a pointer to the past-the-end pair of the flat_map.
+ * @param {flat_map} map
+ * @return {typeof(map)}
+ */
+#define flat_map_end(map) \
+    ((map)+v_size(map))
+
+/**
+ * @brief Turns a vector of pairs filled in arbitrary order into a flat_map: sorts it by key and removes duplicate keys once.
+ *        Of pairs with equal keys the one pushed first is kept.
+ * @param {flat_map} map
+ */
+#define flat_map_build(map)                               \
+    do {                                                  \
+        flat_sort(map, v_size(map), FLAT_MAP_KEY);        \
+        flat_unique(map, FLAT_MAP_KEY);                   \
+    } while(0)
+
+/**
+ * @brief Inserts the pair (k, val) into the flat_map, unless key k is already present.
+ * @param {flat_map} map
+ * @param {K} k
+ * @param {V} val
+ */
+#define flat_map_insert(map, k, val) \
+    flat_insert(map, ((typeof(*(map))){ .key = (k), .value = (val) }), FLAT_MAP_KEY)
+
+/**
+ * @brief Inserts n pairs of array into the flat_map with a single sort and merge.
+ *        Keys already present keep their value.
+ * @param {flat_map} map
+ * @param {typeof(map)} array
+ * @param {size_t} n
+ */
+#define flat_map_insert_range(map, array, n) \
+    flat_insert_range(map, array, n, FLAT_MAP_KEY)
+
+/**
+ * @brief Removes the pair with key k, if present.
+ * @param {flat_map} map
+ * @param {K} k
+ */
+#define flat_map_erase(map, k) \
+    flat_erase(map, k, FLAT_MAP_KEY)
+
+/**
+ * @brief Stores in index the position of the first pair whose key is not less than k.
+ * @param {flat_map} map
+ * @param {K} k
+ * @param {size_t} index
+ */
+#define flat_map_lower_bound(map, k, index) \
+    flat_lower_bound(map, k, index, FLAT_MAP_KEY)
+
+/**
+ * @brief Stores in index the position of the pair with key k, or NPOS if it is not present.
+ * @param {flat_map} map
+ * @param {K} k
+ * @param {size_t} index
+ */
+#define flat_map_find(map, k, index) \
+    flat_find(map, k, index, FLAT_MAP_KEY)
+
+/**
+ * @brief Builds a read-optimized Eytzinger layout of the flat_map.
+ *        The layout is a snapshot: it has to be rebuilt after the flat_map is modified.
+ * @param {flat_map_eytzinger} eytzinger
+ * @param {flat_map} map
+ */
+#define flat_map_eytzinger_build(eytzinger, map) \
+    flat_eytzinger_build(eytzinger, map)
+
+/**
+ * @brief Stores in result a pointer to the pair with key k within the Eytzinger layout, or NULL if it is not present.
+ * @param {flat_map_eytzinger} eytzinger
+ * @param {K} k
+ * @param {typeof(map)} result
+ */
+#define flat_map_eytzinger_find(eytzinger, k, result) \
+    flat_eytzinger_find(eytzinger, k, result, FLAT_MAP_KEY)
+
+/**
+ * @brief Destructs an Eytzinger layout
+ * @param {flat_map_eytzinger} eytzinger
+ */
+#define flat_map_eytzinger_free(eytzinger) \
+    v_free(eytzinger)
@@ -0,0 +1,415 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#ifndef flat_stdlib
+#define flat_stdlib
+#include <stdlib.h> // malloc() free()
+#endif // #ifndef flat_stdlib
+
+#ifndef flat_string
+#define flat_string
+#include <string.h> // memcpy() memmove()
+#endif // #ifndef flat_string
+
+#include "vector.h"
+
+/**
+ * @brief NPOS is a constant value with the greatest possible value for an element of type size_t.
+ *        As a return value, it is usually used to indicate no matches.
+ */
+#ifndef NPOS
+#define NPOS -1ULL
+#endif // #ifndef NPOS
+
+/**
+ * @brief Size of a cache line in bytes, used to pick the prefetch distance of Eytzinger searches
+ */
+#ifndef FLAT_CACHE_LINE
+#define FLAT_CACHE_LINE 64
+#endif // #ifndef FLAT_CACHE_LINE
+
+/**
+ * @brief Hints the processor to pull the cache line holding address into cache
+ * @private
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define flat_prefetch(address) __builtin_prefetch(address)
+#else
+#define flat_prefetch(address) ((void)0)
+#endif
+
+/**
+ * @brief Key accessor of flat_set, the element is its own key
+ * @private
+ */
+#define FLAT_SET_KEY(element) (element)
+
+/**
+ * @brief Sorts n elements of array in ascending order of KEY(element).
+ *        Bottom-up merge sort, so it is stable: elements with equal keys keep their relative order.
+ *        Falls back to insertion sort if the scratch buffer can't be allocated.
+ * @param {T*} array
+ * @param {size_t} n
+ * @param {macro} KEY
+ * @private
+ */
+#define flat_sort(array, n, KEY)                                                                         \
+    do {                                                                                                 \
+        size_t flat_n = (n);                                                                             \
+        typeof(array) flat_src = (array);                                                                \
+        typeof(array) flat_dst = flat_n > 1 ? malloc(flat_n*sizeof(*flat_src)) : NULL;                   \
+        if(flat_dst) {                                                                                   \
+            for(size_t flat_w = 1; flat_w < flat_n; flat_w *= 2) {                                       \
+                for(size_t flat_lo = 0; flat_lo < flat_n; flat_lo += 2*flat_w) {                         \
+                    size_t flat_mid = flat_lo+flat_w < flat_n ? flat_lo+flat_w : flat_n;                 \
+                    size_t flat_hi = flat_lo+2*flat_w < flat_n ? flat_lo+2*flat_w : flat_n;              \
+                    size_t flat_i = flat_lo, flat_j = flat_mid, flat_k = flat_lo;                        \
+                    while(flat_i < flat_mid && flat_j < flat_hi)                                         \
+                        flat_dst[flat_k++] = KEY(flat_src[flat_j]) < KEY(flat_src[flat_i])               \
+                                           ? flat_src[flat_j++] : flat_src[flat_i++];                    \
+                    while(flat_i < flat_mid) flat_dst[flat_k++] = flat_src[flat_i++];                    \
+                    while(flat_j < flat_hi) flat_dst[flat_k++] = flat_src[flat_j++];                     \
+                }                                                                                        \
+                typeof(array) flat_tmp = flat_src; flat_src = flat_dst; flat_dst = flat_tmp;             \
+            }                                                                                            \
+            if(flat_src != (array)) {                                                                    \
+                memcpy((array), flat_src, flat_n*sizeof(*flat_src));                                     \
+                flat_dst = flat_src;                                                                     \
+            }                                                                                            \
+            free(flat_dst);                                                                              \
+        } else {                                                                                         \
+            for(size_t flat_i = 1; flat_i < flat_n; flat_i++) {                                          \
+                typeof(*flat_src) flat_val = flat_src[flat_i];                                           \
+                size_t flat_j = flat_i;                                                                  \
+                for(; flat_j && KEY(flat_val) < KEY(flat_src[flat_j-1]); flat_j--)                       \
+                    flat_src[flat_j] = flat_src[flat_j-1];                                               \
+                flat_src[flat_j] = flat_val;                                                             \
+            }                                                                                            \
+        }                                                                                                \
+    } while(0)
+
+/**
+ * @brief Removes consecutive elements with equal keys from a sorted vector, keeping the first of each run.
+ * @param {vector} vector
+ * @param {macro} KEY
+ * @private
+ */
+#define flat_unique(vector, KEY)                                                  \
+    do {                                                                          \
+        size_t flat_n = v_size(vector), flat_w = flat_n ? 1 : 0;                  \
+        for(size_t flat_r = 1; flat_r < flat_n; flat_r++) {                       \
+            (vector)[flat_w] = (vector)[flat_r];                                  \
+            flat_w += KEY((vector)[flat_w-1]) < KEY((vector)[flat_r]);            \
+        }                                                                         \
+        if(vector) { v_meta(vector)->size = flat_w; }                             \
+    } while(0)
+
+/**
+ * @brief Stores in index the position of the first element whose key is not less than key.
+ *        Branchless binary search: the loop runs exactly ceil(log2(size)) times and the
+ *        comparison only selects the next base, which compiles to a conditional move.
+ * @param {vector} vector
+ * @param {K} key
+ * @param {size_t} index
+ * @param {macro} KEY
+ * @private
+ */
+#define flat_lower_bound(vector, key, index, KEY)                                           \
+    do {                                                                                    \
+        size_t flat_n = v_size(vector);                                                     \
+        typeof(vector) flat_base = (vector);                                                \
+        if(flat_n) {                                                                        \
+            while(flat_n > 1) {                                                             \
+                size_t flat_half = flat_n/2;                                                \
+                flat_base = KEY(flat_base[flat_half]) < (key) ? flat_base+flat_half : flat_base; \
+                flat_n -= flat_half;                                                        \
+            }                                                                               \
+            flat_base += KEY(*flat_base) < (key);                                           \
+        }                                                                                   \
+        (index) = flat_base-(vector);                                                       \
+    } while(0)
+
+/**
+ * @brief Stores in index the position of the element with given key, or NPOS if there is none.
+ * @param {vector} vector
+ * @param {K} key
+ * @param {size_t} index
+ * @param {macro} KEY
+ * @private
+ */
+#define flat_find(vector, key, index, KEY)                                                \
+    do {                                                                                  \
+        size_t flat_pos;                                                                  \
+        flat_lower_bound(vector, key, flat_pos, KEY);                                     \
+        (index) = flat_pos < v_size(vector) && !((key) < KEY((vector)[flat_pos])) ? flat_pos : NPOS; \
+    } while(0)
+
+/**
+ * @brief Inserts val keeping the vector sorted, unless an element with an equal key is already present.
+ * @param {vector} vector
+ * @param {T} val
+ * @param {macro} KEY
+ * @private
+ */
+#define flat_insert(vector, val, KEY)                                                                     \
+    do {                                                                                                  \
+        typeof(*(vector)) flat_val = (val);                                                               \
+        size_t flat_pos;                                                                                  \
+        flat_lower_bound(vector, KEY(flat_val), flat_pos, KEY);                                           \
+        if(flat_pos == v_size(vector) || KEY(flat_val) < KEY((vector)[flat_pos])) {                       \
+            if(v_size(vector) == v_capacity(vector)) { v_grow(vector); }                                  \
+            if(v_size(vector) < v_capacity(vector)) {                                                     \
+                memmove((vector)+flat_pos+1, (vector)+flat_pos, (v_size(vector)-flat_pos)*sizeof(*(vector))); \
+                (vector)[flat_pos] = flat_val;                                                            \
+                v_meta(vector)->size++;                                                                   \
+            }                                                                                             \
+        }                                                                                                 \
+    } while(0)
+
+/**
+ * @brief Inserts n elements of array in a single pass.
+ *        The batch is copied and sorted once, then merged into the vector from the back, so no
+ *        existing element is moved more than once. Keys already present are left untouched.
+ * @param {vector} vector
+ * @param {T*} array
+ * @param {size_t} n
+ * @param {macro} KEY
+ * @private
+ */
+#define flat_insert_range(vector, array, n, KEY)                                                          \
+    do {                                                                                                  \
+        size_t flat_count = (n), flat_old = v_size(vector);                                               \
+        typeof(vector) flat_batch = flat_count ? malloc(flat_count*sizeof(*(vector))) : NULL;             \
+        if(flat_batch) {                                                                                  \
+            memcpy(flat_batch, (array), flat_count*sizeof(*(vector)));                                    \
+            flat_sort(flat_batch, flat_count, KEY);                                                       \
+            v_reserve(vector, flat_old+flat_count);                                                       \
+            if(v_capacity(vector) >= flat_old+flat_count) {                                              \
+                size_t flat_i = flat_old, flat_j = flat_count, flat_k = flat_old+flat_count;              \
+                while(flat_j) {                                                                           \
+                    /* on equal keys the existing element ends up first and survives flat_unique */       \
+                    if(flat_i && KEY(flat_batch[flat_j-1]) < KEY((vector)[flat_i-1]))                     \
+                        (vector)[--flat_k] = (vector)[--flat_i];                                          \
+                    else (vector)[--flat_k] = flat_batch[--flat_j];                                       \
+                }                                                                                         \
+                v_meta(vector)->size = flat_old+flat_count;                                               \
+                flat_unique(vector, KEY);                                                                 \
+            }                                                                                             \
+            free(flat_batch);                                                                             \
+        }                                                                                                 \
+    } while(0)
+
+/**
+ * @brief Removes the element with given key, if present.
+ * @param {vector} vector
+ * @param {K} key
+ * @param {macro} KEY
+ * @private
+ */
+#define flat_erase(vector, key, KEY)                                                                          \
+    do {                                                                                                      \
+        size_t flat_idx;                                                                                      \
+        flat_find(vector, key, flat_idx, KEY);                                                                \
+        if(flat_idx != NPOS) {                                                                                \
+            memmove((vector)+flat_idx, (vector)+flat_idx+1, (v_size(vector)-flat_idx-1)*sizeof(*(vector)));   \
+            v_meta(vector)->size--;                                                                           \
+        }                                                                                                     \
+    } while(0)
+
+/**
+ * @brief Builds the Eytzinger (breadth-first) layout of a sorted vector.
+ *        eytzinger[1] is the root and the children of eytzinger[k] are eytzinger[2k] and eytzinger[2k+1];
+ *        eytzinger[0] is unused. The sorted vector is walked once in order while an in-order traversal
+ *        of the implicit tree assigns each element its slot.
+ * @param {vector} eytzinger
+ * @param {vector} vector
+ * @private
+ */
+#define flat_eytzinger_build(eytzinger, vector)                                            \
+    do {                                                                                   \
+        size_t flat_n = v_size(vector);                                                    \
+        v_reserve(eytzinger, flat_n+1);                                                    \
+        if(v_capacity(eytzinger) >= flat_n+1) {                                            \
+            size_t flat_k = 1;                                                             \
+            while(2*flat_k <= flat_n) flat_k *= 2;                                         \
+            for(size_t flat_i = 0; flat_i < flat_n; flat_i++) {                            \
+                (eytzinger)[flat_k] = (vector)[flat_i];                                    \
+                if(2*flat_k+1 <= flat_n) {                                                 \
+                    flat_k = 2*flat_k+1;                                                   \
+                    while(2*flat_k <= flat_n) flat_k *= 2;                                 \
+                } else {                                                                   \
+                    while(flat_k & 1) flat_k >>= 1;                                        \
+                    flat_k >>= 1;                                                          \
+                }                                                                          \
+            }                                                                              \
+            v_meta(eytzinger)->size = flat_n+1;                                            \
+        }                                                                                  \
+    } while(0)
+
+/**
+ * @brief Stores in result a pointer to the element of an Eytzinger layout with given key, or NULL if there is none.
+ *        Each step prefetches the cache line holding the descendants a few levels down, so the memory
+ *        latency of the next levels overlaps with the comparisons of the current ones.
+ * @param {vector} eytzinger
+ * @param {K} key
+ * @param {T*} result
+ * @param {macro} KEY
+ * @private
+ */
+#define flat_eytzinger_find(eytzinger, key, result, KEY)                                                      \
+    do {                                                                                                      \
+        size_t flat_n = v_size(eytzinger) ? v_size(eytzinger)-1 : 0, flat_k = 1;                              \
+        size_t flat_stride = FLAT_CACHE_LINE/sizeof(*(eytzinger)) ? FLAT_CACHE_LINE/sizeof(*(eytzinger)) : 1; \
+        while(flat_k <= flat_n) {                                                                             \
+            flat_prefetch((eytzinger)+flat_k*flat_stride);                                                    \
+            flat_k = 2*flat_k + (KEY((eytzinger)[flat_k]) < (key));                                           \
+        }                                                                                                     \
+        /* drop the trailing right turns and the final left turn to get the lower bound */                    \
+        flat_k >>= __builtin_ffsll(~flat_k);                                                                  \
+        (result) = flat_k && !((key) < KEY((eytzinger)[flat_k])) ? (eytzinger)+flat_k : NULL;                 \
+    } while(0)
+
+/**
+ * @brief Standardization of the syntax for definition of a flat_set.
+ *        A flat_set is a vector kept sorted and free of duplicates, so it can be used with every v_ function
+ *        that doesn't modify it.
+ * @param {Type} T
+ */
+#define flat_set(T) vector(T)
+
+/**
+ * @brief Standardization of the syntax for definition of a read-optimized Eytzinger layout of a flat_set
+ * @param {Type} T
+ */
+#define flat_set_eytzinger(T) vector(T)
+
+/**
+ * @brief Destructs a flat_set
+ * @param {flat_set} set
+ */
+#define flat_set_free(set) \
+    v_free(set)
+
+/**
+ * @brief Returns the number of elements in the flat_set.
+ * @param {flat_set} set
+ * @return size_t
+ */
+#define flat_set_size(set) \
+    v_size(set)
+
+/**
+ * @brief Checks whether there are any elements in flat_set
+ * @param {flat_set} set
+ * @return boolean
+ */
+#define flat_set_empty(set) \
+    v_empty(set)
+
+/**
+ * @brief Returns a pointer to the smallest element of the flat_set.
+ * @param {flat_set} set
+ * @return {T*}
+ */
+#define flat_set_begin(set) \
+    (set)
+
+/**
+ * @brief Returns a pointer to the past-the-end element of the flat_set.
+ * @param {flat_set} set
+ * @return {T*}
+ */
+#define flat_set_end(set) \
+    ((set)+v_size(set))
+
+/**
+ * @brief Turns a vector filled in arbitrary order into a flat_set: sorts it and removes duplicates once.
+ *        Building in bulk is O(n log n), as opposed to O(n^2) for n calls to flat_set_insert().
+ * @param {flat_set} set
+ */
+#define flat_set_build(set)                               \
+    do {                                                  \
+        flat_sort(set, v_size(set), FLAT_SET_KEY);        \
+        flat_unique(set, FLAT_SET_KEY);                   \
+    } while(0)
+
+/**
+ * @brief Inserts val into the flat_set, unless an equal element is already present.
+ * @param {flat_set} set
+ * @param {T} val
+ */
+#define flat_set_insert(set, val) \
+    flat_insert(set, val, FLAT_SET_KEY)
+
+/**
+ * @brief Inserts n elements of array into the flat_set with a single sort and merge.
+ * @param {flat_set} set
+ * @param {T*} array
+ * @param {size_t} n
+ */
+#define flat_set_insert_range(set, array, n) \
+    flat_insert_range(set, array, n, FLAT_SET_KEY)
+
+/**
+ * @brief Removes val from the flat_set, if present.
+ * @param {flat_set} set
+ * @param {T} val
+ */
+#define flat_set_erase(set, val) \
+    flat_erase(set, val, FLAT_SET_KEY)
+
+/**
+ * @brief Stores in index the position of the first element that is not less than val.
+ * @param {flat_set} set
+ * @param {T} val
+ * @param {size_t} index
+ */
+#define flat_set_lower_bound(set, val, index) \
+    flat_lower_bound(set, val, index, FLAT_SET_KEY)
+
+/**
+ * @brief Stores in index the position of val in the flat_set, or NPOS if it is not present.
+ * @param {flat_set} set
+ * @param {T} val
+ * @param {size_t} index
+ */
+#define flat_set_find(set, val, index) \
+    flat_find(set, val, index, FLAT_SET_KEY)
+
+/**
+ * @brief Builds a read-optimized Eytzinger layout of the flat_set.
+ *        The layout is a snapshot: it has to be rebuilt after the flat_set is modified.
+ * @param {flat_set_eytzinger} eytzinger
+ * @param {flat_set} set
+ */
+#define flat_set_eytzinger_build(eytzinger, set) \
+    flat_eytzinger_build(eytzinger, set)
+
+/**
+ * @brief Stores in result a pointer to val within the Eytzinger layout, or NULL if it is not present.
+ * @param {flat_set_eytzinger} eytzinger
+ * @param {T} val
+ * @param {T*} result
+ */
+#define flat_set_eytzinger_find(eytzinger, val, result) \
+    flat_eytzinger_find(eytzinger, val, result, FLAT_SET_KEY)
+
+/**
+ * @brief Destructs an Eytzinger layout
+ * @param {flat_set_eytzinger} eytzinger
+ */
+#define flat_set_eytzinger_free(eytzinger) \
+    v_free(eytzinger)
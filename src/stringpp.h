@@ -24,11 +24,16 @@ limitations under the License.
 #include <string.h> // memcpy() memmove()
 #endif // #ifndef STRING_STRING
 
+#include "stringpp_utf8.h" // stringpp_utf8_validate() stringpp_utf8_length() stringpp_utf8_decode() ...
+#include "stringpp_hash.h" // stringpp_hash()
+
 /**
  * @brief Helper struct for storing information about the vector, it is stored at string[-1]
+ *        hash caches string_hash(), 0 means it isn't computed (content hashing to 0 is simply never cached).
+ *        pool is the string_pool owning an interned string, NULL for any other string.
  * @private
  */
-#define STRING_META_DATA struct { size_t size; size_t capacity; }
+#define STRING_META_DATA struct { size_t size; size_t capacity; uint64_t hash; void* pool; }
 #define STRING_META_SIZE sizeof(STRING_META_DATA)
 
 /**
@@ -40,7 +45,9 @@ limitations under the License.
  * @brief NPOS is a constant value with the greatest possible value for an element of type size_t.
  *        As a return value, it is usually used to indicate no matches.
  */
+#ifndef NPOS
 #define NPOS -1ULL
+#endif // #ifndef NPOS
 
 /**
  * @brief Returns memory adress of string's meta data
@@ -72,20 +79,22 @@ limitations under the License.
  * @private
  */
 #define DEFAULT_STRING_CAPACITY 32
-#define string_grow(string)                                                                                              \
-    do {                                                                                                                 \
-        void* p = NULL;                                                                                                  \
-        if(string_capacity(string)) { p = realloc(string-STRING_META_SIZE, string_meta(string)->capacity*(*string)*2); } \
-        else {                                                                                                           \
-            p = malloc(DEFAULT_STRING_CAPACITY*sizeof(*string)+STRING_META_SIZE);                                        \
-            ((STRING_META_DATA*)p)->size = 0;                                                                            \
-            ((STRING_META_DATA*)p)->capacity = 0;                                                                        \
-        }                                                                                                                \
-        if(p != NULL) {                                                                                                  \
-            string = p+STRING_META_SIZE;                                                                                 \
-            size_t capacity = string_meta(string)->capacity;                                                             \
-            string_meta(string)->capacity = capacity ? capacity<<1 : DEFAULT_STRING_CAPACITY;                            \
-        }                                                                                                                \
+#define string_grow(string)                                                                                                                     \
+    do {                                                                                                                                        \
+        void* p = NULL;                                                                                                                         \
+        if(string_capacity(string)) { p = realloc(string-STRING_META_SIZE, string_meta(string)->capacity*sizeof(*string)*2+STRING_META_SIZE); } \
+        else {                                                                                                                                  \
+            p = malloc(DEFAULT_STRING_CAPACITY*sizeof(*string)+STRING_META_SIZE);                                                               \
+            ((STRING_META_DATA*)p)->size = 0;                                                                                                   \
+            ((STRING_META_DATA*)p)->capacity = 0;                                                                                               \
+            ((STRING_META_DATA*)p)->hash = 0;                                                                                                   \
+            ((STRING_META_DATA*)p)->pool = NULL;                                                                                                \
+        }                                                                                                                                       \
+        if(p != NULL) {                                                                                                                         \
+            string = p+STRING_META_SIZE;                                                                                                        \
+            size_t capacity = string_meta(string)->capacity;                                                                                    \
+            string_meta(string)->capacity = capacity ? capacity<<1 : DEFAULT_STRING_CAPACITY;                                                   \
+        }                                                                                                                                       \
     }  while(0)
 
 /**
@@ -165,10 +174,142 @@ limitations under the License.
 	
 /**
  * Appends character c to the end of the string, increasing its length by one.
+ * Must not be used on an interned string.
  * @param {string} string
  * @param {char} c
  */
 #define string_push_back(string, c)                                               \
     if(string_length(string) == string_capacity(string)) { string_grow(string); } \
     string[string_length(string)] = (c);                                          \
-    string_meta(string)->size++;
+    string_meta(string)->size++;                                                  \
+    string_meta(string)->hash = 0;
+
+/**
+ * @brief Returns whether the string is valid UTF-8.
+ *        Uses AVX2 or SSE4.1 when the processor supports them, a scalar loop otherwise.
+ * @param {string} string
+ * @returns {bool}
+ */
+#define string_utf8_validate(string) \
+    stringpp_utf8_validate(string, string_length(string))
+
+/**
+ * @brief Returns the length of the string, in terms of UTF-8 code points. The string must be valid UTF-8.
+ * @param {string} string
+ * @returns {size_t}
+ */
+#define string_utf8_length(string) \
+    stringpp_utf8_length(string, string_length(string))
+
+/**
+ * @brief Returns the code point starting at byte pos of the string and advances pos past it.
+ *        A malformed sequence yields STRING_UTF8_INVALID and advances pos by one byte.
+ *        for(size_t i = 0; i < string_length(s);) { uint32_t cp = string_utf8_next(s, i); ... }
+ * @param {string} string
+ * @param {size_t} pos
+ * @returns {uint32_t}
+ */
+#define string_utf8_next(string, pos) \
+    stringpp_utf8_decode(string, string_length(string), &(pos))
+
+/**
+ * @brief Transcodes the string to UTF-16. dst must have room for string_length(string) units.
+ * @param {string} string
+ * @param {uint16_t*} dst
+ * @returns {size_t} number of units written, NPOS if the string isn't valid UTF-8
+ */
+#define string_utf8_to_utf16(string, dst) \
+    stringpp_utf8_to_utf16(string, string_length(string), dst)
+
+/**
+ * @brief Transcodes the string to UTF-32. dst must have room for string_length(string) units.
+ * @param {string} string
+ * @param {uint32_t*} dst
+ * @returns {size_t} number of units written, NPOS if the string isn't valid UTF-8
+ */
+#define string_utf8_to_utf32(string, dst) \
+    stringpp_utf8_to_utf32(string, string_length(string), dst)
+
+/**
+ * @brief Appends n UTF-32 code units from src to the string, encoded as UTF-8.
+ *        Surrogates and values above U+10FFFF are replaced with U+FFFD.
+ * @param {string} string
+ * @param {const uint32_t*} src
+ * @param {size_t} n
+ */
+#define string_append_utf32(string, src, n)                                      \
+    do {                                                                         \
+        for(size_t string_i = 0; string_i < (size_t)(n); string_i++) {           \
+            char string_buf[4];                                                  \
+            size_t string_k = stringpp_utf8_encode((src)[string_i], string_buf); \
+            if(!string_k) string_k = stringpp_utf8_encode(0xFFFD, string_buf);   \
+            for(size_t string_j = 0; string_j < string_k; string_j++) {          \
+                string_push_back(string, string_buf[string_j]);                  \
+            }                                                                    \
+        }                                                                        \
+    } while(0)
+
+/**
+ * @brief Appends n UTF-16 code units from src to the string, encoded as UTF-8.
+ *        Unpaired surrogates are replaced with U+FFFD.
+ * @param {string} string
+ * @param {const uint16_t*} src
+ * @param {size_t} n
+ */
+#define string_append_utf16(string, src, n)                                                               \
+    do {                                                                                                  \
+        for(size_t string_i = 0; string_i < (size_t)(n);) {                                               \
+            char string_buf[4];                                                                           \
+            size_t string_k = stringpp_utf8_encode(stringpp_utf16_decode(src, n, &string_i), string_buf); \
+            if(!string_k) string_k = stringpp_utf8_encode(0xFFFD, string_buf);                            \
+            for(size_t string_j = 0; string_j < string_k; string_j++) {                                   \
+                string_push_back(string, string_buf[string_j]);                                           \
+            }                                                                                             \
+        }                                                                                                 \
+    } while(0)
+
+/**
+ * @brief Returns the 64 bit hash of the string's content.
+ *        The hash is computed once and cached in the string's meta data; functions modifying the string drop the cached value.
+ *        After writing to the string directly (e.g. through string_at()) call string_hash_invalidate().
+ * @param {string} string
+ * @returns {uint64_t}
+ */
+#define string_hash(string)                                                   \
+    (!string ? stringpp_hash(NULL, 0)                                         \
+     : string_meta(string)->hash ? string_meta(string)->hash                  \
+     : (string_meta(string)->hash = stringpp_hash(string, string_length(string))))
+
+/**
+ * @brief Drops the cached hash of the string, it will be recomputed by the next string_hash().
+ * @param {string} string
+ */
+#define string_hash_invalidate(string)                \
+    do {                                              \
+        if(string) { string_meta(string)->hash = 0; } \
+    } while(0)
+
+/**
+ * @brief Returns whether the string is the canonical copy owned by a string_pool (see stringpp_pool.h).
+ * @param {string} string
+ * @returns {bool}
+ */
+#define string_is_interned(string) \
+    (string ? string_meta(string)->pool != NULL : 0)
+
+/**
+ * @brief Returns whether both strings have the same content.
+ *        Two strings interned in the same string_pool are compared by address only, since the pool keeps a single copy
+ *        of each content. Otherwise the lengths are compared, then the cached hashes when both strings have one, and
+ *        finally the bytes.
+ * @param {string} a
+ * @param {string} b
+ * @returns {bool}
+ */
+#define string_equal(a, b)                                                                                   \
+    ((a) == (b) ? 1                                                                                          \
+     : string_is_interned(a) && string_is_interned(b) && string_meta(a)->pool == string_meta(b)->pool ? 0    \
+     : string_length(a) == string_length(b)                                                                  \
+       && (!(string_length(a) && string_meta(a)->hash && string_meta(b)->hash)                               \
+           || string_meta(a)->hash == string_meta(b)->hash)                                                  \
+       && (string_length(a) == 0 || memcmp(a, b, string_length(a)) == 0))
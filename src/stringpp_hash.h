@@ -0,0 +1,124 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+Byte hash used by stringpp.h, in the style of wyhash: input is read 8 or 4 bytes at a time and mixed
+with a 64x64->128 bit multiply folded back to 64 bits, which is a couple of cycles per 16 bytes on
+64-bit targets. It is not meant to resist hash flooding.
+*/
+
+#pragma once
+
+#ifndef STRING_STDINT
+#define STRING_STDINT
+#include <stdint.h> // uint8_t uint16_t uint32_t
+#endif // #ifndef STRING_STDINT
+
+#ifndef STRING_STDDEF
+#define STRING_STDDEF
+#include <stddef.h> // size_t
+#endif // #ifndef STRING_STDDEF
+
+#ifndef STRING_STRING
+#define STRING_STRING
+#include <string.h> // memcpy() memmove()
+#endif // #ifndef STRING_STRING
+
+/**
+ * @brief Seed of string_hash(), change it to get a different family of hashes
+ */
+#ifndef STRING_HASH_SEED
+#define STRING_HASH_SEED 0ULL
+#endif // #ifndef STRING_HASH_SEED
+
+/**
+ * @brief Multiplies *a by *b and stores the low half of the 128 bit product in *a and the high half in *b.
+ *        Targets without a 128 bit integer type (32-bit, MSVC) build the product from four 32x32 bit products.
+ * @private
+ */
+static inline void stringpp_hash_mum(uint64_t* a, uint64_t* b) {
+#ifdef __SIZEOF_INT128__
+    __uint128_t r = (__uint128_t)*a * *b;
+    *a = (uint64_t)r;
+    *b = (uint64_t)(r>>64);
+#else
+    uint64_t ha = *a>>32, la = (uint32_t)*a, hb = *b>>32, lb = (uint32_t)*b;
+    uint64_t hh = ha*hb, hl = ha*lb, lh = la*hb, ll = la*lb;
+    uint64_t mid = (ll>>32) + (uint32_t)hl + (uint32_t)lh;
+    *a = (mid<<32) | (uint32_t)ll;
+    *b = hh + (hl>>32) + (lh>>32) + (mid>>32);
+#endif // #ifdef __SIZEOF_INT128__
+}
+
+/**
+ * @brief Multiplies a by b and returns the xor of the low and high halves of the 128 bit product
+ * @private
+ */
+static inline uint64_t stringpp_hash_mix(uint64_t a, uint64_t b) {
+    stringpp_hash_mum(&a, &b);
+    return a ^ b;
+}
+
+/**
+ * @brief Unaligned little-endian reads
+ * @private
+ */
+static inline uint64_t stringpp_hash_read8(const uint8_t* p) { uint64_t v; memcpy(&v, p, 8); return v; }
+static inline uint64_t stringpp_hash_read4(const uint8_t* p) { uint32_t v; memcpy(&v, p, 4); return v; }
+
+/**
+ * @brief Returns the 64 bit hash of len bytes starting at data
+ * @param {const void*} data
+ * @param {size_t} len
+ * @returns {uint64_t}
+ * @private
+ */
+static inline uint64_t stringpp_hash(const void* data, size_t len) {
+    static const uint64_t secret[4] = { 0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL, 0x8ebc6af09c88c6e3ULL, 0x589965cc75374cc3ULL };
+    const uint8_t* p = (const uint8_t*)data;
+    uint64_t seed = STRING_HASH_SEED ^ stringpp_hash_mix(STRING_HASH_SEED ^ secret[0], secret[1]);
+    uint64_t a, b;
+    if(len <= 16) {
+        if(len >= 4) {
+            /* two possibly overlapping 4 byte reads from each end cover 4..16 bytes */
+            a = (stringpp_hash_read4(p)<<32) | stringpp_hash_read4(p+((len>>3)<<2));
+            b = (stringpp_hash_read4(p+len-4)<<32) | stringpp_hash_read4(p+len-4-((len>>3)<<2));
+        } else if(len > 0) {
+            a = ((uint64_t)p[0]<<16) | ((uint64_t)p[len>>1]<<8) | p[len-1];
+            b = 0;
+        } else a = b = 0;
+    } else {
+        size_t i = len;
+        if(i > 48) {
+            /* three independent lanes keep the multipliers busy */
+            uint64_t seed1 = seed, seed2 = seed;
+            do {
+                seed = stringpp_hash_mix(stringpp_hash_read8(p)^secret[1], stringpp_hash_read8(p+8)^seed);
+                seed1 = stringpp_hash_mix(stringpp_hash_read8(p+16)^secret[2], stringpp_hash_read8(p+24)^seed1);
+                seed2 = stringpp_hash_mix(stringpp_hash_read8(p+32)^secret[3], stringpp_hash_read8(p+40)^seed2);
+                p += 48, i -= 48;
+            } while(i > 48);
+            seed ^= seed1^seed2;
+        }
+        while(i > 16) {
+            seed = stringpp_hash_mix(stringpp_hash_read8(p)^secret[1], stringpp_hash_read8(p+8)^seed);
+            p += 16, i -= 16;
+        }
+        a = stringpp_hash_read8(p+i-16);
+        b = stringpp_hash_read8(p+i-8);
+    }
+    a ^= secret[1], b ^= seed;
+    stringpp_hash_mum(&a, &b);
+    return stringpp_hash_mix(a^secret[0]^len, b^secret[1]);
+}
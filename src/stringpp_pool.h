@@ -0,0 +1,184 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+String interning for stringpp.h. A string_pool keeps one canonical copy of every distinct content
+it is given, so equal strings interned in the same pool are the same pointer and string_equal() on
+them is an address compare. Canonical copies are ordinary strings (meta data included, hash precomputed) carved out of
+large arena blocks, and are found again through an open addressing table keyed by their cached hash.
+*/
+
+#pragma once
+
+#include "stringpp.h"
+
+/**
+ * @brief Size of an arena block, strings longer than a quarter of it get a block of their own
+ */
+#ifndef STRING_POOL_BLOCK_SIZE
+#define STRING_POOL_BLOCK_SIZE (64*1024)
+#endif // #ifndef STRING_POOL_BLOCK_SIZE
+
+/**
+ * @brief Initial number of slots of the pool's table, must be a power of 2
+ */
+#define DEFAULT_STRING_POOL_CAPACITY 64
+
+/**
+ * @brief Arena block header, blocks are chained through it so the pool can free them all
+ * @private
+ */
+struct stringpp_pool_block {
+    struct stringpp_pool_block* prev;
+    size_t used;
+    size_t size;
+};
+
+/**
+ * @brief Declaration of string pool type
+ */
+#define string_pool struct stringpp_pool*
+struct stringpp_pool {
+    char** slots;    // canonical strings, NULL for an empty slot
+    size_t count;    // number of canonical strings
+    size_t capacity; // number of slots, a power of 2
+    struct stringpp_pool_block* block;
+};
+
+/**
+ * @brief Allocates room for a canonical string of len bytes (plus meta data and a terminating 0) from the arena
+ * @private
+ */
+static inline char* stringpp_pool_alloc(struct stringpp_pool* pool, size_t len) {
+    const size_t align = sizeof(uint64_t);
+    size_t need = (STRING_META_SIZE+len+1+align-1) & ~(align-1);
+    struct stringpp_pool_block* block = pool->block;
+    if(!block || block->size-block->used < need) {
+        size_t size = need > STRING_POOL_BLOCK_SIZE/4 ? need : STRING_POOL_BLOCK_SIZE;
+        struct stringpp_pool_block* fresh = malloc(sizeof(*fresh)+size);
+        if(!fresh) return NULL;
+        fresh->size = size;
+        fresh->used = 0;
+        if(block && size != STRING_POOL_BLOCK_SIZE) {
+            /* oversized strings go behind the current block so its free space isn't wasted */
+            fresh->prev = block->prev;
+            block->prev = fresh;
+        } else {
+            fresh->prev = block;
+            pool->block = fresh;
+        }
+        block = fresh;
+    }
+    char* p = (char*)(block+1)+block->used;
+    block->used += need;
+    return p+STRING_META_SIZE;
+}
+
+/**
+ * @brief Doubles the pool's table and reinserts every canonical string using its cached hash
+ * @private
+ */
+static inline int stringpp_pool_grow(struct stringpp_pool* pool) {
+    size_t capacity = pool->capacity ? pool->capacity*2 : DEFAULT_STRING_POOL_CAPACITY;
+    char** slots = calloc(capacity, sizeof(*slots));
+    if(!slots) return 0;
+    for(size_t i = 0; i < pool->capacity; i++) {
+        char* s = pool->slots[i];
+        if(!s) continue;
+        size_t j = string_meta(s)->hash & (capacity-1);
+        while(slots[j]) j = (j+1) & (capacity-1);
+        slots[j] = s;
+    }
+    free(pool->slots);
+    pool->slots = slots;
+    pool->capacity = capacity;
+    return 1;
+}
+
+/**
+ * @brief Returns the canonical copy of len bytes starting at chars, creating it on first sight.
+ *        hash must be stringpp_hash(chars, len). Returns NULL if memory runs out.
+ * @private
+ */
+static inline char* stringpp_pool_intern(struct stringpp_pool* pool, const char* chars, size_t len, uint64_t hash) {
+    /* keep the load factor at most 1/2 so probe sequences stay short */
+    if(2*(pool->count+1) > pool->capacity && !stringpp_pool_grow(pool)) return NULL;
+    size_t mask = pool->capacity-1, i = hash & mask;
+    for(char* s; (s = pool->slots[i]); i = (i+1) & mask) {
+        if(string_meta(s)->hash == hash && string_length(s) == len && (len == 0 || memcmp(s, chars, len) == 0)) return s;
+    }
+    char* s = stringpp_pool_alloc(pool, len);
+    if(!s) return NULL;
+    if(len) memcpy(s, chars, len);
+    s[len] = 0;
+    string_meta(s)->size = len;
+    string_meta(s)->capacity = len;
+    string_meta(s)->hash = hash;
+    string_meta(s)->pool = pool;
+    pool->slots[i] = s;
+    pool->count++;
+    return s;
+}
+
+/**
+ * @brief Initializes an empty string pool
+ * @param {string_pool} pool
+ */
+#define string_pool_init(pool) \
+    pool = calloc(1, sizeof(*pool))
+
+/**
+ * @brief Destructs a string pool together with every string interned in it
+ * @param {string_pool} pool
+ */
+#define string_pool_free(pool)                                   \
+    do {                                                         \
+        while(pool->block) {                                     \
+            struct stringpp_pool_block* prev = pool->block->prev; \
+            free(pool->block);                                   \
+            pool->block = prev;                                  \
+        }                                                        \
+        free(pool->slots);                                       \
+        free(pool);                                              \
+        pool = NULL;                                             \
+    } while(0)
+
+/**
+ * @brief Returns the number of distinct strings interned in the pool.
+ * @param {string_pool} pool
+ * @returns {size_t}
+ */
+#define string_pool_size(pool) \
+    (pool ? pool->count : 0)
+
+/**
+ * @brief Returns the pool's canonical copy of the string, creating it if the content wasn't seen before.
+ *        The string itself is left untouched (and still has to be freed by the caller), only its hash gets cached.
+ *        The canonical copy is owned by the pool: it must not be modified nor passed to string_free().
+ * @param {string_pool} pool
+ * @param {string} string
+ * @returns {string}
+ */
+#define string_intern(pool, string) \
+    stringpp_pool_intern(pool, string, string_length(string), string_hash(string))
+
+/**
+ * @brief Returns the pool's canonical copy of len bytes starting at chars, without building a string first.
+ * @param {string_pool} pool
+ * @param {const char*} chars
+ * @param {size_t} len
+ * @returns {string}
+ */
+#define string_intern_chars(pool, chars, len) \
+    stringpp_pool_intern(pool, chars, len, stringpp_hash(chars, len))
@@ -0,0 +1,558 @@
+/*
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+/*
+UTF-8 kernels used by stringpp.h. Unlike the containers these can't be macros, so they are
+static inline functions working on plain (pointer, length) pairs.
+
+Validation follows the lookup algorithm of Keiser and Lemire ("Validating UTF-8 In Less Than One
+Instruction Per Byte"): every byte is classified with three 16-entry table lookups on its own high
+nibble and on the nibbles of the byte before it, and the AND of the three results is non-zero exactly
+where a 2-byte pattern is illegal. Whether a continuation byte is expected two or three bytes after a
+lead byte is checked separately. On x86 an AVX2 and an SSE4.1 version are picked at runtime, everything
+else uses the scalar code.
+*/
+
+#pragma once
+
+#ifndef STRING_STDINT
+#define STRING_STDINT
+#include <stdint.h> // uint8_t uint16_t uint32_t
+#endif // #ifndef STRING_STDINT
+
+#ifndef STRING_STDDEF
+#define STRING_STDDEF
+#include <stddef.h> // size_t
+#endif // #ifndef STRING_STDDEF
+
+#ifndef STRING_STRING
+#define STRING_STRING
+#include <string.h> // memcpy() memmove()
+#endif // #ifndef STRING_STRING
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define STRING_UTF8_X86 1
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief NPOS is a constant value with the greatest possible value for an element of type size_t.
+ *        As a return value, it is usually used to indicate no matches.
+ */
+#ifndef NPOS
+#define NPOS -1ULL
+#endif // #ifndef NPOS
+
+/**
+ * @brief Value returned by stringpp_utf8_decode() for a malformed sequence
+ */
+#define STRING_UTF8_INVALID 0xFFFFFFFFu
+
+/**
+ * @brief Scalar validation of len bytes of UTF-8 starting at s.
+ *        Rejects overlong encodings, surrogates, code points above U+10FFFF and truncated sequences.
+ * @param {const char*} s
+ * @param {size_t} len
+ * @returns {int}
+ * @private
+ */
+static inline int stringpp_utf8_validate_scalar(const char* s, size_t len) {
+    const uint8_t* p = (const uint8_t*)s;
+    size_t i = 0;
+    while(i < len) {
+        uint8_t c = p[i];
+        if(c < 0x80) { i++; continue; }
+        size_t n;
+        uint8_t lo = 0x80, hi = 0xBF;
+        if(c >= 0xC2 && c <= 0xDF) n = 1;
+        else if(c >= 0xE0 && c <= 0xEF) {
+            n = 2;
+            if(c == 0xE0) lo = 0xA0;      // overlong
+            else if(c == 0xED) hi = 0x9F; // surrogates
+        } else if(c >= 0xF0 && c <= 0xF4) {
+            n = 3;
+            if(c == 0xF0) lo = 0x90;      // overlong
+            else if(c == 0xF4) hi = 0x8F; // above U+10FFFF
+        } else return 0;
+        if(len-i <= n) return 0;
+        if(p[i+1] < lo || p[i+1] > hi) return 0;
+        for(size_t k = 2; k <= n; k++)
+            if((p[i+k] & 0xC0) != 0x80) return 0;
+        i += n+1;
+    }
+    return 1;
+}
+
+/**
+ * @brief Decodes the code point starting at byte *pos and moves *pos past it.
+ *        On a malformed sequence returns STRING_UTF8_INVALID and moves *pos by one byte, so iteration always advances.
+ * @param {const char*} s
+ * @param {size_t} len
+ * @param {size_t*} pos
+ * @returns {uint32_t}
+ * @private
+ */
+static inline uint32_t stringpp_utf8_decode(const char* s, size_t len, size_t* pos) {
+    const uint8_t* p = (const uint8_t*)s+*pos;
+    size_t left = len-*pos;
+    uint32_t cp;
+    size_t n;
+    if(p[0] < 0x80) { (*pos)++; return p[0]; }
+    else if(p[0] >= 0xC2 && p[0] <= 0xDF) n = 2, cp = p[0] & 0x1F;
+    else if(p[0] >= 0xE0 && p[0] <= 0xEF) n = 3, cp = p[0] & 0x0F;
+    else if(p[0] >= 0xF0 && p[0] <= 0xF4) n = 4, cp = p[0] & 0x07;
+    else { (*pos)++; return STRING_UTF8_INVALID; }
+    if(left < n || !stringpp_utf8_validate_scalar((const char*)p, n)) { (*pos)++; return STRING_UTF8_INVALID; }
+    for(size_t k = 1; k < n; k++) cp = (cp<<6) | (p[k] & 0x3F);
+    *pos += n;
+    return cp;
+}
+
+/**
+ * @brief Encodes code point cp as UTF-8 into out (at least 4 bytes) and returns the number of bytes written.
+ *        Surrogates and values above U+10FFFF are not encodable and yield 0.
+ * @param {uint32_t} cp
+ * @param {char*} out
+ * @returns {size_t}
+ * @private
+ */
+static inline size_t stringpp_utf8_encode(uint32_t cp, char* out) {
+    if(cp < 0x80) { out[0] = (char)cp; return 1; }
+    if(cp < 0x800) {
+        out[0] = (char)(0xC0 | (cp>>6));
+        out[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if(cp < 0x10000) {
+        if(cp >= 0xD800 && cp <= 0xDFFF) return 0;
+        out[0] = (char)(0xE0 | (cp>>12));
+        out[1] = (char)(0x80 | ((cp>>6) & 0x3F));
+        out[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    if(cp <= 0x10FFFF) {
+        out[0] = (char)(0xF0 | (cp>>18));
+        out[1] = (char)(0x80 | ((cp>>12) & 0x3F));
+        out[2] = (char)(0x80 | ((cp>>6) & 0x3F));
+        out[3] = (char)(0x80 | (cp & 0x3F));
+        return 4;
+    }
+    return 0;
+}
+
+/**
+ * @brief Counts the code points of valid UTF-8, i.e. the bytes which are not continuation bytes (10xxxxxx)
+ * @private
+ */
+static inline size_t stringpp_utf8_length_scalar(const char* s, size_t len) {
+    size_t count = 0;
+    for(size_t i = 0; i < len; i++) count += ((uint8_t)s[i] & 0xC0) != 0x80;
+    return count;
+}
+
+#ifdef STRING_UTF8_X86
+
+/*
+Error bits of the lookup tables, each names a way a pair of consecutive bytes can be illegal.
+They are char values so that entries with the top bit set fit the char arguments of _mm_setr_epi8().
+*/
+#define STRING_UTF8_TOO_SHORT      ((char)(1<<0)) // lead byte followed by a lead byte or ASCII
+#define STRING_UTF8_TOO_LONG       ((char)(1<<1)) // ASCII followed by a continuation byte
+#define STRING_UTF8_OVERLONG_3     ((char)(1<<2)) // 11100000 100xxxxx
+#define STRING_UTF8_TOO_LARGE      ((char)(1<<3)) // 11110100 1001xxxx and above
+#define STRING_UTF8_SURROGATE      ((char)(1<<4)) // 11101101 101xxxxx
+#define STRING_UTF8_OVERLONG_2     ((char)(1<<5)) // 1100000x 10xxxxxx
+#define STRING_UTF8_TOO_LARGE_1000 ((char)(1<<6)) // 11110101+ 1000xxxx
+#define STRING_UTF8_OVERLONG_4     ((char)(1<<6)) // 11110000 1000xxxx
+#define STRING_UTF8_TWO_CONTS      ((char)(1<<7)) // two continuation bytes in a row, legal only inside a 3 or 4 byte sequence
+#define STRING_UTF8_CARRY          (STRING_UTF8_TOO_SHORT | STRING_UTF8_TOO_LONG | STRING_UTF8_TWO_CONTS)
+
+/* indexed by the high nibble of the first byte of the pair */
+#define STRING_UTF8_BYTE_1_HIGH                                                                      \
+    STRING_UTF8_TOO_LONG, STRING_UTF8_TOO_LONG, STRING_UTF8_TOO_LONG, STRING_UTF8_TOO_LONG,          \
+    STRING_UTF8_TOO_LONG, STRING_UTF8_TOO_LONG, STRING_UTF8_TOO_LONG, STRING_UTF8_TOO_LONG,          \
+    STRING_UTF8_TWO_CONTS, STRING_UTF8_TWO_CONTS, STRING_UTF8_TWO_CONTS, STRING_UTF8_TWO_CONTS,      \
+    STRING_UTF8_TOO_SHORT | STRING_UTF8_OVERLONG_2,                                                  \
+    STRING_UTF8_TOO_SHORT,                                                                           \
+    STRING_UTF8_TOO_SHORT | STRING_UTF8_OVERLONG_3 | STRING_UTF8_SURROGATE,                          \
+    STRING_UTF8_TOO_SHORT | STRING_UTF8_TOO_LARGE | STRING_UTF8_TOO_LARGE_1000 | STRING_UTF8_OVERLONG_4
+
+/* indexed by the low nibble of the first byte of the pair */
+#define STRING_UTF8_BYTE_1_LOW                                                                       \
+    STRING_UTF8_CARRY | STRING_UTF8_OVERLONG_3 | STRING_UTF8_OVERLONG_2 | STRING_UTF8_OVERLONG_4,     \
+    STRING_UTF8_CARRY | STRING_UTF8_OVERLONG_2,                                                      \
+    STRING_UTF8_CARRY,                                                                               \
+    STRING_UTF8_CARRY,                                                                               \
+    STRING_UTF8_CARRY | STRING_UTF8_TOO_LARGE,                                                       \
+    STRING_UTF8_CARRY | STRING_UTF8_TOO_LARGE | STRING_UTF8_TOO_LARGE_1000,                          \
+    STRING_UTF8_CARRY | STRING_UTF8_TOO_LARGE | STRING_UTF8_TOO_LARGE_1000,                          \
+    STRING_UTF8_CARRY | STRING_UTF8_TOO_LARGE | STRING_UTF8_TOO_LARGE_1000,                          \
+    STRING_UTF8_CARRY | STRING_UTF8_TOO_LARGE | STRING_UTF8_TOO_LARGE_1000,                          \
+    STRING_UTF8_CARRY | STRING_UTF8_TOO_LARGE | STRING_UTF8_TOO_LARGE_1000,                          \
+    STRING_UTF8_CARRY | STRING_UTF8_TOO_LARGE | STRING_UTF8_TOO_LARGE_1000,                          \
+    STRING_UTF8_CARRY | STRING_UTF8_TOO_LARGE | STRING_UTF8_TOO_LARGE_1000,                          \
+    STRING_UTF8_CARRY | STRING_UTF8_TOO_LARGE | STRING_UTF8_TOO_LARGE_1000,                          \
+    STRING_UTF8_CARRY | STRING_UTF8_TOO_LARGE | STRING_UTF8_TOO_LARGE_1000 | STRING_UTF8_SURROGATE,  \
+    STRING_UTF8_CARRY | STRING_UTF8_TOO_LARGE | STRING_UTF8_TOO_LARGE_1000,                          \
+    STRING_UTF8_CARRY | STRING_UTF8_TOO_LARGE | STRING_UTF8_TOO_LARGE_1000
+
+/* indexed by the high nibble of the second byte of the pair */
+#define STRING_UTF8_BYTE_2_HIGH                                                                                                                          \
+    STRING_UTF8_TOO_SHORT, STRING_UTF8_TOO_SHORT, STRING_UTF8_TOO_SHORT, STRING_UTF8_TOO_SHORT,                                                          \
+    STRING_UTF8_TOO_SHORT, STRING_UTF8_TOO_SHORT, STRING_UTF8_TOO_SHORT, STRING_UTF8_TOO_SHORT,                                                          \
+    STRING_UTF8_TOO_LONG | STRING_UTF8_OVERLONG_2 | STRING_UTF8_TWO_CONTS | STRING_UTF8_OVERLONG_3 | STRING_UTF8_TOO_LARGE_1000 | STRING_UTF8_OVERLONG_4, \
+    STRING_UTF8_TOO_LONG | STRING_UTF8_OVERLONG_2 | STRING_UTF8_TWO_CONTS | STRING_UTF8_OVERLONG_3 | STRING_UTF8_TOO_LARGE,                              \
+    STRING_UTF8_TOO_LONG | STRING_UTF8_OVERLONG_2 | STRING_UTF8_TWO_CONTS | STRING_UTF8_SURROGATE | STRING_UTF8_TOO_LARGE,                               \
+    STRING_UTF8_TOO_LONG | STRING_UTF8_OVERLONG_2 | STRING_UTF8_TWO_CONTS | STRING_UTF8_SURROGATE | STRING_UTF8_TOO_LARGE,                               \
+    STRING_UTF8_TOO_SHORT, STRING_UTF8_TOO_SHORT, STRING_UTF8_TOO_SHORT, STRING_UTF8_TOO_SHORT
+
+/**
+ * @brief SSE4.1 validation, 16 bytes per step. The tail is copied into a zero padded block (zeros are ASCII).
+ * @private
+ */
+__attribute__((target("sse4.1")))
+static inline int stringpp_utf8_validate_sse4(const char* s, size_t len) {
+    const __m128i byte_1_high = _mm_setr_epi8(STRING_UTF8_BYTE_1_HIGH);
+    const __m128i byte_1_low = _mm_setr_epi8(STRING_UTF8_BYTE_1_LOW);
+    const __m128i byte_2_high = _mm_setr_epi8(STRING_UTF8_BYTE_2_HIGH);
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    /* any of the last 3 bytes starting a sequence longer than what's left of the block */
+    const __m128i incomplete_max = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                                 (char)(0xF0-1), (char)(0xE0-1), (char)(0xC0-1));
+    __m128i error = _mm_setzero_si128(), prev_input = _mm_setzero_si128(), prev_incomplete = _mm_setzero_si128();
+    char tail[16];
+    for(size_t i = 0; i < len; i += 16) {
+        __m128i input;
+        if(len-i >= 16) input = _mm_loadu_si128((const __m128i*)(s+i));
+        else {
+            memset(tail, 0, sizeof(tail));
+            memcpy(tail, s+i, len-i);
+            input = _mm_loadu_si128((const __m128i*)tail);
+        }
+        if(_mm_movemask_epi8(input) == 0) {
+            /* ASCII block: only an unfinished sequence from the previous block can be wrong */
+            error = _mm_or_si128(error, prev_incomplete);
+        } else {
+            __m128i prev1 = _mm_alignr_epi8(input, prev_input, 15);
+            __m128i special = _mm_and_si128(
+                _mm_and_si128(_mm_shuffle_epi8(byte_1_high, _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble)),
+                              _mm_shuffle_epi8(byte_1_low, _mm_and_si128(prev1, nibble))),
+                _mm_shuffle_epi8(byte_2_high, _mm_and_si128(_mm_srli_epi16(input, 4), nibble)));
+            __m128i prev2 = _mm_alignr_epi8(input, prev_input, 14);
+            __m128i prev3 = _mm_alignr_epi8(input, prev_input, 13);
+            __m128i must23 = _mm_or_si128(_mm_subs_epu8(prev2, _mm_set1_epi8((char)(0xE0-0x80))),
+                                          _mm_subs_epu8(prev3, _mm_set1_epi8((char)(0xF0-0x80))));
+            __m128i must23_80 = _mm_and_si128(must23, _mm_set1_epi8((char)0x80));
+            error = _mm_or_si128(error, _mm_xor_si128(must23_80, special));
+            prev_incomplete = _mm_subs_epu8(input, incomplete_max);
+        }
+        prev_input = input;
+    }
+    error = _mm_or_si128(error, prev_incomplete);
+    return _mm_testz_si128(error, error);
+}
+
+/**
+ * @brief AVX2 validation, 32 bytes per step. Same algorithm as stringpp_utf8_validate_sse4().
+ * @private
+ */
+__attribute__((target("avx2")))
+static inline int stringpp_utf8_validate_avx2(const char* s, size_t len) {
+    const __m256i byte_1_high = _mm256_setr_epi8(STRING_UTF8_BYTE_1_HIGH, STRING_UTF8_BYTE_1_HIGH);
+    const __m256i byte_1_low = _mm256_setr_epi8(STRING_UTF8_BYTE_1_LOW, STRING_UTF8_BYTE_1_LOW);
+    const __m256i byte_2_high = _mm256_setr_epi8(STRING_UTF8_BYTE_2_HIGH, STRING_UTF8_BYTE_2_HIGH);
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    const __m256i incomplete_max = _mm256_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                                    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                                    (char)(0xF0-1), (char)(0xE0-1), (char)(0xC0-1));
+    __m256i error = _mm256_setzero_si256(), prev_input = _mm256_setzero_si256(), prev_incomplete = _mm256_setzero_si256();
+    char tail[32];
+    for(size_t i = 0; i < len; i += 32) {
+        __m256i input;
+        if(len-i >= 32) input = _mm256_loadu_si256((const __m256i*)(s+i));
+        else {
+            memset(tail, 0, sizeof(tail));
+            memcpy(tail, s+i, len-i);
+            input = _mm256_loadu_si256((const __m256i*)tail);
+        }
+        if(_mm256_movemask_epi8(input) == 0) {
+            error = _mm256_or_si256(error, prev_incomplete);
+        } else {
+            /* alignr works per 128 bit lane, so the lane boundary is fed from a permuted copy */
+            __m256i shifted = _mm256_permute2x128_si256(prev_input, input, 0x21);
+            __m256i prev1 = _mm256_alignr_epi8(input, shifted, 15);
+            __m256i special = _mm256_and_si256(
+                _mm256_and_si256(_mm256_shuffle_epi8(byte_1_high, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble)),
+                                 _mm256_shuffle_epi8(byte_1_low, _mm256_and_si256(prev1, nibble))),
+                _mm256_shuffle_epi8(byte_2_high, _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble)));
+            __m256i prev2 = _mm256_alignr_epi8(input, shifted, 14);
+            __m256i prev3 = _mm256_alignr_epi8(input, shifted, 13);
+            __m256i must23 = _mm256_or_si256(_mm256_subs_epu8(prev2, _mm256_set1_epi8((char)(0xE0-0x80))),
+                                             _mm256_subs_epu8(prev3, _mm256_set1_epi8((char)(0xF0-0x80))));
+            __m256i must23_80 = _mm256_and_si256(must23, _mm256_set1_epi8((char)0x80));
+            error = _mm256_or_si256(error, _mm256_xor_si256(must23_80, special));
+            prev_incomplete = _mm256_subs_epu8(input, incomplete_max);
+        }
+        prev_input = input;
+    }
+    error = _mm256_or_si256(error, prev_incomplete);
+    return _mm256_testz_si256(error, error);
+}
+
+/**
+ * @brief SSE4.1 code point count: a byte starts a code point unless it is in 0x80..0xBF, i.e. -128..-65 as signed
+ * @private
+ */
+__attribute__((target("sse4.1,popcnt")))
+static inline size_t stringpp_utf8_length_sse4(const char* s, size_t len) {
+    const __m128i threshold = _mm_set1_epi8(-65);
+    size_t count = 0, i = 0;
+    for(; i+16 <= len; i += 16) {
+        __m128i starts = _mm_cmpgt_epi8(_mm_loadu_si128((const __m128i*)(s+i)), threshold);
+        count += __builtin_popcount(_mm_movemask_epi8(starts));
+    }
+    return count+stringpp_utf8_length_scalar(s+i, len-i);
+}
+
+/**
+ * @brief AVX2 code point count, see stringpp_utf8_length_sse4()
+ * @private
+ */
+__attribute__((target("avx2,popcnt")))
+static inline size_t stringpp_utf8_length_avx2(const char* s, size_t len) {
+    const __m256i threshold = _mm256_set1_epi8(-65);
+    size_t count = 0, i = 0;
+    for(; i+32 <= len; i += 32) {
+        __m256i starts = _mm256_cmpgt_epi8(_mm256_loadu_si256((const __m256i*)(s+i)), threshold);
+        count += __builtin_popcount((uint32_t)_mm256_movemask_epi8(starts));
+    }
+    return count+stringpp_utf8_length_scalar(s+i, len-i);
+}
+
+/**
+ * @brief Widens the ASCII prefix of s to UTF-16, 16 bytes per step, stopping at the first non-ASCII byte.
+ *        Returns the number of bytes (and units) converted. A block holding a non-ASCII byte is stored whole, so
+ *        dst gets written up to 16 units past the returned count, which stays within the len units it has room for.
+ * @private
+ */
+__attribute__((target("sse4.1")))
+static inline size_t stringpp_ascii_to_utf16_sse4(const char* s, size_t len, uint16_t* dst) {
+    size_t i = 0;
+    for(; i+16 <= len; i += 16) {
+        __m128i in = _mm_loadu_si128((const __m128i*)(s+i));
+        int mask = _mm_movemask_epi8(in);
+        _mm_storeu_si128((__m128i*)(dst+i), _mm_cvtepu8_epi16(in));
+        _mm_storeu_si128((__m128i*)(dst+i+8), _mm_cvtepu8_epi16(_mm_srli_si128(in, 8)));
+        if(mask) return i+__builtin_ctz(mask);
+    }
+    return i;
+}
+
+/**
+ * @brief Widens the ASCII prefix of s to UTF-32, see stringpp_ascii_to_utf16_sse4()
+ * @private
+ */
+__attribute__((target("sse4.1")))
+static inline size_t stringpp_ascii_to_utf32_sse4(const char* s, size_t len, uint32_t* dst) {
+    size_t i = 0;
+    for(; i+16 <= len; i += 16) {
+        __m128i in = _mm_loadu_si128((const __m128i*)(s+i));
+        int mask = _mm_movemask_epi8(in);
+        _mm_storeu_si128((__m128i*)(dst+i), _mm_cvtepu8_epi32(in));
+        _mm_storeu_si128((__m128i*)(dst+i+4), _mm_cvtepu8_epi32(_mm_srli_si128(in, 4)));
+        _mm_storeu_si128((__m128i*)(dst+i+8), _mm_cvtepu8_epi32(_mm_srli_si128(in, 8)));
+        _mm_storeu_si128((__m128i*)(dst+i+12), _mm_cvtepu8_epi32(_mm_srli_si128(in, 12)));
+        if(mask) return i+__builtin_ctz(mask);
+    }
+    return i;
+}
+
+/**
+ * @brief Widens the ASCII prefix of s to UTF-16, 32 bytes per step
+ * @private
+ */
+__attribute__((target("avx2")))
+static inline size_t stringpp_ascii_to_utf16_avx2(const char* s, size_t len, uint16_t* dst) {
+    size_t i = 0;
+    for(; i+32 <= len; i += 32) {
+        __m256i in = _mm256_loadu_si256((const __m256i*)(s+i));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(in);
+        _mm256_storeu_si256((__m256i*)(dst+i), _mm256_cvtepu8_epi16(_mm256_castsi256_si128(in)));
+        _mm256_storeu_si256((__m256i*)(dst+i+16), _mm256_cvtepu8_epi16(_mm256_extracti128_si256(in, 1)));
+        if(mask) return i+__builtin_ctz(mask);
+    }
+    return i;
+}
+
+/**
+ * @brief Widens the ASCII prefix of s to UTF-32, 32 bytes per step
+ * @private
+ */
+__attribute__((target("avx2")))
+static inline size_t stringpp_ascii_to_utf32_avx2(const char* s, size_t len, uint32_t* dst) {
+    size_t i = 0;
+    for(; i+32 <= len; i += 32) {
+        __m256i in = _mm256_loadu_si256((const __m256i*)(s+i));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(in);
+        __m128i lo = _mm256_castsi256_si128(in), hi = _mm256_extracti128_si256(in, 1);
+        _mm256_storeu_si256((__m256i*)(dst+i), _mm256_cvtepu8_epi32(lo));
+        _mm256_storeu_si256((__m256i*)(dst+i+8), _mm256_cvtepu8_epi32(_mm_srli_si128(lo, 8)));
+        _mm256_storeu_si256((__m256i*)(dst+i+16), _mm256_cvtepu8_epi32(hi));
+        _mm256_storeu_si256((__m256i*)(dst+i+24), _mm256_cvtepu8_epi32(_mm_srli_si128(hi, 8)));
+        if(mask) return i+__builtin_ctz(mask);
+    }
+    return i;
+}
+
+#endif // #ifdef STRING_UTF8_X86
+
+/**
+ * @brief Returns whether len bytes starting at s are valid UTF-8, using the widest kernel the CPU supports
+ * @private
+ */
+static inline int stringpp_utf8_validate(const char* s, size_t len) {
+#ifdef STRING_UTF8_X86
+    if(__builtin_cpu_supports("avx2")) return stringpp_utf8_validate_avx2(s, len);
+    if(__builtin_cpu_supports("sse4.1")) return stringpp_utf8_validate_sse4(s, len);
+#endif
+    return stringpp_utf8_validate_scalar(s, len);
+}
+
+/**
+ * @brief Returns the number of code points in len bytes of valid UTF-8 starting at s
+ * @private
+ */
+static inline size_t stringpp_utf8_length(const char* s, size_t len) {
+#ifdef STRING_UTF8_X86
+    if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) return stringpp_utf8_length_avx2(s, len);
+    if(__builtin_cpu_supports("sse4.1") && __builtin_cpu_supports("popcnt")) return stringpp_utf8_length_sse4(s, len);
+#endif
+    return stringpp_utf8_length_scalar(s, len);
+}
+
+/**
+ * @brief Widens the ASCII prefix of s to UTF-16 one byte at a time, stopping at the first non-ASCII byte.
+ *        Fallback for processors without SIMD kernels. Returns the number of bytes (and units) converted.
+ * @private
+ */
+static inline size_t stringpp_ascii_to_utf16_scalar(const char* s, size_t len, uint16_t* dst) {
+    size_t i = 0;
+    for(; i < len && (uint8_t)s[i] < 0x80; i++) dst[i] = (uint8_t)s[i];
+    return i;
+}
+
+/**
+ * @brief Widens the ASCII prefix of s to UTF-32, see stringpp_ascii_to_utf16_scalar()
+ * @private
+ */
+static inline size_t stringpp_ascii_to_utf32_scalar(const char* s, size_t len, uint32_t* dst) {
+    size_t i = 0;
+    for(; i < len && (uint8_t)s[i] < 0x80; i++) dst[i] = (uint8_t)s[i];
+    return i;
+}
+
+/**
+ * @brief Transcodes len bytes of UTF-8 to UTF-16, dst must have room for len units.
+ *        The kernel is picked once per call. ASCII is widened with SIMD up to the first non-ASCII byte, even inside
+ *        a block holding one, then the non-ASCII run is decoded in scalar and the vector kernel takes over again.
+ *        Returns the number of units written, or NPOS if the input isn't valid UTF-8.
+ * @private
+ */
+static inline size_t stringpp_utf8_to_utf16(const char* s, size_t len, uint16_t* dst) {
+    size_t (*widen)(const char*, size_t, uint16_t*) = stringpp_ascii_to_utf16_scalar;
+    size_t block = 1; // the scalar widener has no tail, every ASCII run goes back to it
+#ifdef STRING_UTF8_X86
+    if(__builtin_cpu_supports("avx2")) widen = stringpp_ascii_to_utf16_avx2, block = 32;
+    else if(__builtin_cpu_supports("sse4.1")) widen = stringpp_ascii_to_utf16_sse4, block = 16;
+#endif
+    size_t i = 0, n = 0;
+    while(i < len) {
+        size_t ascii = widen(s+i, len-i, dst+n);
+        i += ascii, n += ascii;
+        /* the vector kernel stopped at a non-ASCII byte or at a tail shorter than a block */
+        int tail = len-i < block;
+        while(i < len) {
+            uint8_t c = (uint8_t)s[i];
+            if(c < 0x80) {
+                if(!tail) break;
+                dst[n++] = c, i++;
+                continue;
+            }
+            if(c >= 0xC2 && c <= 0xDF && i+1 < len && ((uint8_t)s[i+1] & 0xC0) == 0x80) {
+                dst[n++] = (uint16_t)((c & 0x1F)<<6 | ((uint8_t)s[i+1] & 0x3F));
+                i += 2;
+                continue;
+            }
+            uint32_t cp = stringpp_utf8_decode(s, len, &i);
+            if(cp == STRING_UTF8_INVALID) return NPOS;
+            if(cp >= 0x10000) {
+                cp -= 0x10000;
+                dst[n++] = (uint16_t)(0xD800 | (cp>>10));
+                dst[n++] = (uint16_t)(0xDC00 | (cp & 0x3FF));
+            } else dst[n++] = (uint16_t)cp;
+        }
+    }
+    return n;
+}
+
+/**
+ * @brief Transcodes len bytes of UTF-8 to UTF-32, dst must have room for len units.
+ *        Works like stringpp_utf8_to_utf16().
+ *        Returns the number of units written, or NPOS if the input isn't valid UTF-8.
+ * @private
+ */
+static inline size_t stringpp_utf8_to_utf32(const char* s, size_t len, uint32_t* dst) {
+    size_t (*widen)(const char*, size_t, uint32_t*) = stringpp_ascii_to_utf32_scalar;
+    size_t block = 1; // the scalar widener has no tail, every ASCII run goes back to it
+#ifdef STRING_UTF8_X86
+    if(__builtin_cpu_supports("avx2")) widen = stringpp_ascii_to_utf32_avx2, block = 32;
+    else if(__builtin_cpu_supports("sse4.1")) widen = stringpp_ascii_to_utf32_sse4, block = 16;
+#endif
+    size_t i = 0, n = 0;
+    while(i < len) {
+        size_t ascii = widen(s+i, len-i, dst+n);
+        i += ascii, n += ascii;
+        /* the vector kernel stopped at a non-ASCII byte or at a tail shorter than a block */
+        int tail = len-i < block;
+        while(i < len) {
+            uint8_t c = (uint8_t)s[i];
+            if(c < 0x80) {
+                if(!tail) break;
+                dst[n++] = c, i++;
+                continue;
+            }
+            if(c >= 0xC2 && c <= 0xDF && i+1 < len && ((uint8_t)s[i+1] & 0xC0) == 0x80) {
+                dst[n++] = (uint32_t)(c & 0x1F)<<6 | ((uint8_t)s[i+1] & 0x3F);
+                i += 2;
+                continue;
+            }
+            uint32_t cp = stringpp_utf8_decode(s, len, &i);
+            if(cp == STRING_UTF8_INVALID) return NPOS;
+            dst[n++] = cp;
+        }
+    }
+    return n;
+}
+
+/**
+ * @brief Reads the code point starting at unit *pos of UTF-16 and moves *pos past it.
+ *        Returns STRING_UTF8_INVALID for an unpaired surrogate.
+ * @private
+ */
+static inline uint32_t stringpp_utf16_decode(const uint16_t* src, size_t n, size_t* pos) {
+    uint32_t hi = src[(*pos)++];
+    if(hi < 0xD800 || hi > 0xDFFF) return hi;
+    if(hi > 0xDBFF || *pos == n || src[*pos] < 0xDC00 || src[*pos] > 0xDFFF) return STRING_UTF8_INVALID;
+    return 0x10000+((hi-0xD800)<<10)+(src[(*pos)++]-0xDC00);
+}
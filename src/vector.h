@@ -42,7 +42,7 @@ limitations under the License.
  * @private
  */
 #define v_meta(vector) \
-    ((VECTOR_META_DATA*)(vector-VECTOR_META_SIZE))
+    ((VECTOR_META_DATA*)((char*)(vector)-VECTOR_META_SIZE))
 
 /**
  * @brief Returns number of bytes vector allocates, including meta data
@@ -73,20 +73,20 @@ limitations under the License.
  * @param {vector}
  */
 #define DEFAULT_VECTOR_CAPACITY 32
-#define v_grow(vector)                                                                                         \
-    do {                                                                                                       \
-        void* p = NULL;                                                                                        \
-        if(v_capacity(vector)) { p = realloc(vector-VECTOR_META_SIZE, v_meta(vector)->capacity*(*vector)*2); } \
-        else {                                                                                                 \
-            p = malloc(DEFAULT_VECTOR_CAPACITY*sizeof(*vector)+VECTOR_META_SIZE);                              \
-            ((VECTOR_META_DATA*)p)->size = 0;                                                                  \
-            ((VECTOR_META_DATA*)p)->capacity = 0;                                                              \
-        }                                                                                                      \
-        if(p != NULL) {                                                                                        \
-            vector = p+VECTOR_META_SIZE;                                                                       \
-            size_t capacity = v_meta(vector)->capacity;                                                        \
-            v_meta(vector)->capacity = capacity ? capacity<<1 : DEFAULT_VECTOR_CAPACITY;                       \
-        }                                                                                                      \
+#define v_grow(vector)                                                                                                         \
+    do {                                                                                                                       \
+        void* v_p = NULL;                                                                                                      \
+        if(v_capacity(vector)) { v_p = realloc(v_meta(vector), v_meta(vector)->capacity*sizeof(*vector)*2+VECTOR_META_SIZE); } \
+        else {                                                                                                                 \
+            v_p = malloc(DEFAULT_VECTOR_CAPACITY*sizeof(*vector)+VECTOR_META_SIZE);                                            \
+            ((VECTOR_META_DATA*)v_p)->size = 0;                                                                                \
+            ((VECTOR_META_DATA*)v_p)->capacity = 0;                                                                            \
+        }                                                                                                                      \
+        if(v_p != NULL) {                                                                                                      \
+            vector = (void*)((char*)v_p+VECTOR_META_SIZE);                                                                     \
+            size_t v_old_capacity = v_meta(vector)->capacity;                                                                  \
+            v_meta(vector)->capacity = v_old_capacity ? v_old_capacity<<1 : DEFAULT_VECTOR_CAPACITY;                           \
+        }                                                                                                                      \
     }  while(0)
 
 /**
@@ -122,12 +122,17 @@ limitations under the License.
  * @param {vector} vector
  * @param {size_t} n
  */
-#define v_reserve(vector, n)                                                         \
-    do {                                                                             \
-        if(n > v_capacity(vector)) {                                                 \
-            void* p = malloc((n)*sizeof(*vector)+VECTOR_META_SIZE);                  \
-            if(p != NULL) vector = p+VECTOR_META_SIZE, v_meta(vector)->capacity = n; \
-        }                                                                            \
+#define v_reserve(vector, n)                                                                           \
+    do {                                                                                               \
+        if((n) > v_capacity(vector)) {                                                                 \
+            size_t v_old_size = v_size(vector);                                                        \
+            void* v_p = realloc(vector ? v_meta(vector) : NULL, (n)*sizeof(*vector)+VECTOR_META_SIZE); \
+            if(v_p != NULL) {                                                                          \
+                vector = (void*)((char*)v_p+VECTOR_META_SIZE);                                         \
+                v_meta(vector)->size = v_old_size;                                                     \
+                v_meta(vector)->capacity = (n);                                                        \
+            }                                                                                          \
+        }                                                                                              \
      } while(0)
 
 /**